@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+
+/** Quicksort with branchless block partitioning (Edelkamp, Weiss. "BlockQuicksort:
+  *  How Branch Mispredictions don't affect Quicksort").
+  *
+  * Ordinary quicksort spends a large part of its time on mispredicted branches
+  *  in the partition step, because the result of each comparison is unpredictable.
+  * Here comparison results are first accumulated into small buffers of offsets
+  *  (the accumulation loop has no data-dependent branches and can be vectorized by the compiler),
+  *  and then the elements are swapped in pairs according to these buffers.
+  *
+  * The interface is the same as std::sort with a comparator.
+  * The comparator must define a strict weak ordering.
+  * Equal elements are distributed to both sides of the pivot (two-way Hoare scheme),
+  *  so arrays with many duplicates do not degrade to quadratic time.
+  */
+
+namespace impl
+{
+
+static constexpr size_t BLOCK_QUICK_SORT_BLOCK = 128;
+static constexpr size_t BLOCK_QUICK_SORT_INSERTION_SORT_THRESHOLD = 24;
+
+
+template <typename RandomIt, typename Compare>
+void insertionSort(RandomIt begin, RandomIt end, Compare less)
+{
+	for (RandomIt i = begin + 1; i < end; ++i)
+	{
+		if (less(*i, *(i - 1)))
+		{
+			auto value = std::move(*i);
+			RandomIt j = i;
+
+			do
+			{
+				*j = std::move(*(j - 1));
+				--j;
+			}
+			while (j > begin && less(value, *(j - 1)));
+
+			*j = std::move(value);
+		}
+	}
+}
+
+
+/** Partitions [begin + 1, end) around the pivot located at *begin,
+  *  then puts the pivot on its final place.
+  * Returns the beginning of the right part; the pivot is right before it.
+  */
+template <typename RandomIt, typename Compare>
+RandomIt blockPartition(RandomIt begin, RandomIt end, Compare less)
+{
+	static constexpr size_t BLOCK = BLOCK_QUICK_SORT_BLOCK;
+
+	const auto pivot = *begin;
+
+	RandomIt l = begin + 1;	/// Inclusive bounds of the not yet partitioned middle part.
+	RandomIt r = end - 1;
+
+	/// Offsets (relative to l forward and to r backward) of elements that are on the wrong side.
+	uint8_t offsets_l[BLOCK];
+	uint8_t offsets_r[BLOCK];
+	size_t num_l = 0;
+	size_t num_r = 0;
+	size_t start_l = 0;
+	size_t start_r = 0;
+
+	while (r - l + 1 > 2 * static_cast<ptrdiff_t>(BLOCK))
+	{
+		if (num_l == 0)
+		{
+			start_l = 0;
+			for (size_t i = 0; i < BLOCK; ++i)
+			{
+				offsets_l[num_l] = i;
+				num_l += !less(l[i], pivot);
+			}
+		}
+
+		if (num_r == 0)
+		{
+			start_r = 0;
+			for (size_t i = 0; i < BLOCK; ++i)
+			{
+				offsets_r[num_r] = i;
+				num_r += !less(pivot, *(r - i));
+			}
+		}
+
+		size_t num = std::min(num_l, num_r);
+		for (size_t i = 0; i < num; ++i)
+			std::iter_swap(l + offsets_l[start_l + i], r - offsets_r[start_r + i]);
+
+		num_l -= num;
+		num_r -= num;
+		start_l += num;
+		start_r += num;
+
+		if (num_l == 0)
+			l += BLOCK;
+		if (num_r == 0)
+			r -= BLOCK;
+	}
+
+	/// Process the remaining middle part with two final blocks that exactly cover it.
+
+	ptrdiff_t remaining = r - l + 1;
+	size_t shift_l;
+	size_t shift_r;
+
+	if (num_l == 0 && num_r == 0)
+	{
+		shift_l = remaining / 2;
+		shift_r = remaining - shift_l;
+		start_l = 0;
+		start_r = 0;
+
+		for (size_t i = 0; i < shift_l; ++i)
+		{
+			offsets_l[num_l] = i;
+			num_l += !less(l[i], pivot);
+		}
+		for (size_t i = 0; i < shift_r; ++i)
+		{
+			offsets_r[num_r] = i;
+			num_r += !less(pivot, *(r - i));
+		}
+	}
+	else if (num_l != 0)
+	{
+		/// The left block is already scanned, only the rest on the right remains.
+		shift_l = BLOCK;
+		shift_r = remaining - BLOCK;
+		start_r = 0;
+
+		for (size_t i = 0; i < shift_r; ++i)
+		{
+			offsets_r[num_r] = i;
+			num_r += !less(pivot, *(r - i));
+		}
+	}
+	else
+	{
+		shift_r = BLOCK;
+		shift_l = remaining - BLOCK;
+		start_l = 0;
+
+		for (size_t i = 0; i < shift_l; ++i)
+		{
+			offsets_l[num_l] = i;
+			num_l += !less(l[i], pivot);
+		}
+	}
+
+	size_t num = std::min(num_l, num_r);
+	for (size_t i = 0; i < num; ++i)
+		std::iter_swap(l + offsets_l[start_l + i], r - offsets_r[start_r + i]);
+
+	num_l -= num;
+	num_r -= num;
+	start_l += num;
+	start_r += num;
+
+	RandomIt boundary;	/// The first element of the right part.
+
+	if (num_l != 0)
+	{
+		/** Only elements inside the left block are on the wrong side.
+		  * Move them, starting from the rightmost, to the end of the block.
+		  */
+		RandomIt upper = l + shift_l - 1;
+		while (num_l > 0)
+		{
+			--num_l;
+			std::iter_swap(l + offsets_l[start_l + num_l], upper);
+			--upper;
+		}
+		boundary = upper + 1;
+	}
+	else if (num_r != 0)
+	{
+		/// Symmetrically: move them to the beginning of the right block.
+		RandomIt lower = r - shift_r + 1;
+		while (num_r > 0)
+		{
+			--num_r;
+			std::iter_swap(r - offsets_r[start_r + num_r], lower);
+			++lower;
+		}
+		boundary = lower;
+	}
+	else
+		boundary = l + shift_l;
+
+	/// Put the pivot right before the right part.
+	std::iter_swap(begin, boundary - 1);
+	return boundary;
+}
+
+
+template <typename RandomIt, typename Compare>
+void blockQuickSortImpl(RandomIt begin, RandomIt end, Compare less, size_t depth)
+{
+	while (end - begin > static_cast<ptrdiff_t>(BLOCK_QUICK_SORT_INSERTION_SORT_THRESHOLD))
+	{
+		if (depth == 0)
+		{
+			/// Too many bad partitions in a row - protect against quadratic behaviour.
+			std::make_heap(begin, end, less);
+			std::sort_heap(begin, end, less);
+			return;
+		}
+		--depth;
+
+		/// Median of three as the pivot; it ends up at *begin.
+		RandomIt mid = begin + (end - begin) / 2;
+		if (less(*mid, *begin))
+			std::iter_swap(mid, begin);
+		if (less(*(end - 1), *mid))
+		{
+			std::iter_swap(end - 1, mid);
+			if (less(*mid, *begin))
+				std::iter_swap(mid, begin);
+		}
+		std::iter_swap(begin, mid);
+
+		RandomIt boundary = blockPartition(begin, end, less);
+
+		/// Recurse into the smaller part, loop on the bigger one.
+		if (boundary - begin < end - boundary)
+		{
+			blockQuickSortImpl(begin, boundary - 1, less, depth);
+			begin = boundary;
+		}
+		else
+		{
+			blockQuickSortImpl(boundary, end, less, depth);
+			end = boundary - 1;
+		}
+	}
+
+	if (end - begin > 1)
+		insertionSort(begin, end, less);
+}
+
+}
+
+
+template <typename RandomIt, typename Compare>
+void blockQuickSort(RandomIt begin, RandomIt end, Compare less)
+{
+	if (end - begin < 2)
+		return;
+
+	size_t depth = 2;
+	for (ptrdiff_t n = end - begin; n > 1; n >>= 1)
+		++depth;
+
+	impl::blockQuickSortImpl(begin, end, less, depth);
+}
+
+template <typename RandomIt>
+void blockQuickSort(RandomIt begin, RandomIt end)
+{
+	using T = typename std::iterator_traits<RandomIt>::value_type;
+	blockQuickSort(begin, end, [](const T & a, const T & b) { return a < b; });
+}
@@ -297,6 +297,22 @@ public:
 		c_end += bytes_to_copy;
 	}
 
+	/** For batched appending: reserve space for n more elements and return the pointer to their beginning.
+	  * After writing through the pointer, the number of actually written elements must be passed to `commit`.
+	  * Hoists the capacity check out of the writing loop - the loop becomes a plain pointer bump
+	  *  that the compiler can vectorize, in contrast to push_back with a check per element.
+	  */
+	T * reserve_and_get_tail(size_t n)
+	{
+		reserve(size() + n);
+		return t_end();
+	}
+
+	void commit(size_t n)
+	{
+		c_end += byte_size(n);
+	}
+
 	void swap(PODArray & rhs)
 	{
 		/// Swap two PODArray objects, arr1 and arr2, that satisfy the following conditions:
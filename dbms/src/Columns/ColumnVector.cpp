@@ -1,15 +1,23 @@
 #include <cstring>
 #include <cmath>
+#include <limits>
+#include <type_traits>
 
 #include <DB/Common/Exception.h>
 #include <DB/Common/Arena.h>
 #include <DB/Common/SipHash.h>
 #include <DB/Common/NaNUtils.h>
+#include <DB/Common/RadixSort.h>
+#include <DB/Common/BlockQuickSort.h>
+#include <DB/Common/ThreadPool.h>
+#include <DB/Common/getNumberOfPhysicalCPUCores.h>
+#include <DB/Common/unaligned.h>
 
 #include <DB/IO/WriteBuffer.h>
 #include <DB/IO/WriteHelpers.h>
 
 #include <DB/Columns/ColumnVector.h>
+#include <DB/Columns/ColumnsCommon.h>
 
 #include <ext/bit_cast.hpp>
 
@@ -17,6 +25,20 @@
 	#include <emmintrin.h>
 #endif
 
+/** The AVX2 and AVX-512 kernels below are compiled even when the translation unit
+  *  is built for a lower instruction set: under GCC the wide intrinsics are available
+  *  in functions with a matching `target` attribute. The actual variant is picked
+  *  once per process by CPUID. This way a generic x86_64 build still uses the wide
+  *  registers of the machine it actually runs on.
+  * Clang defines __GNUC__ but ignores `#pragma GCC target`, turning every wide
+  *  intrinsic in the target regions into a compile error - it gets only the
+  *  compile-time SSE2 path.
+  */
+#if __SSE2__ && defined(__GNUC__) && !defined(__clang__)
+	#define COLUMN_VECTOR_RUNTIME_DISPATCH 1
+	#include <immintrin.h>
+#endif
+
 
 namespace DB
 {
@@ -27,19 +49,74 @@ namespace ErrorCodes
 	extern const int SIZES_OF_COLUMNS_DOESNT_MATCH;
 }
 
+#if COLUMN_VECTOR_RUNTIME_DISPATCH
+
+namespace
+{
+	/// CPUID is not free - the answer is cached after the first call.
+	inline bool haveAVX2()
+	{
+		static const bool res = __builtin_cpu_supports("avx2");
+		return res;
+	}
+
+	inline bool haveAVX512()
+	{
+		static const bool res = __builtin_cpu_supports("avx512f")
+			&& __builtin_cpu_supports("avx512bw")
+			&& __builtin_cpu_supports("avx512vl");
+		return res;
+	}
+}
+
+#if !__AVX2__
+	#pragma GCC push_options
+	#pragma GCC target("avx2")
+	#define COLUMN_VECTOR_POP_TARGET
+#endif
+
+namespace
+{
+	/** Fill a permutation with 0..n-1. The indices are 64-bit, so the scalar loop
+	  *  does one store per value; here four indices are written per store.
+	  */
+	void permutationIotaImplAVX2(size_t * out, size_t n)
+	{
+		size_t i = 0;
+		__m256i value = _mm256_setr_epi64x(0, 1, 2, 3);
+		const __m256i step = _mm256_set1_epi64x(4);
+
+		for (; i + 4 <= n; i += 4)
+		{
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), value);
+			value = _mm256_add_epi64(value, step);
+		}
+
+		for (; i < n; ++i)
+			out[i] = i;
+	}
+}
+
+#ifdef COLUMN_VECTOR_POP_TARGET
+	#pragma GCC pop_options
+	#undef COLUMN_VECTOR_POP_TARGET
+#endif
+
+#endif
+
 
 template <typename T>
 StringRef ColumnVector<T>::serializeValueIntoArena(size_t n, Arena & arena, char const *& begin) const
 {
 	auto pos = arena.allocContinue(sizeof(T), begin);
-	memcpy(pos, &data[n], sizeof(T));
+	unalignedStore(pos, data[n]);
 	return StringRef(pos, sizeof(T));
 }
 
 template <typename T>
 const char * ColumnVector<T>::deserializeAndInsertFromArena(const char * pos)
 {
-	data.push_back(*reinterpret_cast<const T *>(pos));
+	data.push_back(unalignedLoad<T>(pos));
 	return pos + sizeof(T);
 }
 
@@ -65,30 +142,365 @@ struct ColumnVector<T>::greater
 	bool operator()(size_t lhs, size_t rhs) const { return CompareHelper<T>::greater(parent.data[lhs], parent.data[rhs]); }
 };
 
+namespace
+{
+	/** (key, position) pair - an element of the radix sort in getPermutation. */
+	template <typename T>
+	struct ValueWithIndex
+	{
+		T value;
+		UInt32 index;
+	};
+
+	/** The float transform of the radix sort is monotone over the bit patterns, so NaNs
+	  *  with the sign bit set would end up before -inf - but every comparator puts all
+	  *  NaNs (they compare equal to each other) after all normal numbers. Canonicalize
+	  *  NaN keys to the positive quiet NaN, whose bit pattern maps above +inf; `index`
+	  *  still points to the original value.
+	  */
+	template <typename T>
+	typename std::enable_if<std::is_floating_point<T>::value, T>::type
+	canonicalSortKey(T x)
+	{
+		return isNaN(x) ? std::numeric_limits<T>::quiet_NaN() : x;
+	}
+
+	template <typename T>
+	typename std::enable_if<!std::is_floating_point<T>::value, T>::type
+	canonicalSortKey(T x)
+	{
+		return x;
+	}
+
+	/// An UInt of the same size as the key, in which bitwise operations on the key are done.
+	template <typename T, bool is_floating_point = std::is_floating_point<T>::value>
+	struct PermutationRadixSortKeyBits
+	{
+		using Type = typename std::make_unsigned<T>::type;
+	};
+
+	template <typename T>
+	struct PermutationRadixSortKeyBits<T, true>
+	{
+		using Type = typename std::conditional<sizeof(T) == 8, uint64_t, uint32_t>::type;
+	};
+
+	template <typename KeyBits, bool is_floating_point, bool is_signed>
+	struct PermutationRadixSortTransform
+	{
+		using Type = RadixSortIdentityTransform<KeyBits>;
+	};
+
+	template <typename KeyBits, bool is_signed>
+	struct PermutationRadixSortTransform<KeyBits, true, is_signed>
+	{
+		using Type = RadixSortFloatTransform<KeyBits>;
+	};
+
+	template <typename KeyBits>
+	struct PermutationRadixSortTransform<KeyBits, false, true>
+	{
+		using Type = RadixSortSignedTransform<KeyBits>;
+	};
+
+	template <typename T>
+	struct PermutationRadixSortTraits
+	{
+		using Element = ValueWithIndex<T>;
+		using Key = T;
+		using CountType = uint32_t;
+		using KeyBits = typename PermutationRadixSortKeyBits<T>::Type;
+
+		static constexpr size_t PART_SIZE_BITS = 8;
+
+		using Transform = typename PermutationRadixSortTransform<KeyBits,
+			std::is_floating_point<T>::value, std::is_signed<T>::value>::Type;
+		using Allocator = RadixSortMallocAllocator;
+
+		static Key & extractKey(Element & elem) { return elem.value; }
+	};
+
+	/** Parallel version of the LSD radix sort for large arrays.
+	  * Every pass consists of three phases:
+	  *  - each thread builds a histogram of its slice;
+	  *  - a serial prefix sum over (bucket, thread) gives every thread its write
+	  *    positions, in an order that keeps the pass stable;
+	  *  - each thread scatters its slice to those positions.
+	  * A single thread does not saturate memory bandwidth on the scatter,
+	  *  so the scaling with cores is close to linear.
+	  */
+	template <typename Traits>
+	void parallelRadixSort(typename Traits::Element * arr, size_t size, size_t num_threads)
+	{
+		using Element = typename Traits::Element;
+		using KeyBits = typename Traits::KeyBits;
+		using CountType = typename Traits::CountType;
+
+		static constexpr size_t HISTOGRAM_SIZE = 1 << Traits::PART_SIZE_BITS;
+		static constexpr size_t PART_BITMASK = HISTOGRAM_SIZE - 1;
+		static constexpr size_t KEY_BITS = sizeof(typename Traits::Key) * 8;
+		static constexpr size_t NUM_PASSES = (KEY_BITS + (Traits::PART_SIZE_BITS - 1)) / Traits::PART_SIZE_BITS;
+
+		const size_t slice = (size + num_threads - 1) / num_threads;
+
+		PaddedPODArray<Element> swap_buffer(size);
+		std::vector<CountType> histograms(num_threads * HISTOGRAM_SIZE);
+
+		ThreadPool pool(num_threads);
+
+		/// The not-simple transform (floats) is applied to the keys once upfront and reverted at the end.
+		if (!Traits::Transform::transform_is_simple)
+		{
+			for (size_t t = 0; t < num_threads; ++t)
+				pool.schedule([arr, size, slice, t]
+				{
+					size_t end = std::min(size, (t + 1) * slice);
+					for (size_t i = t * slice; i < end; ++i)
+						Traits::extractKey(arr[i]) = ext::bit_cast<typename Traits::Key>(
+							Traits::Transform::forward(ext::bit_cast<KeyBits>(Traits::extractKey(arr[i]))));
+				});
+			pool.wait();
+		}
+
+		Element * reader = arr;
+		Element * writer = &swap_buffer[0];
+
+		for (size_t pass = 0; pass < NUM_PASSES; ++pass)
+		{
+			const auto get_part = [pass](KeyBits x)
+			{
+				if (Traits::Transform::transform_is_simple)
+					x = Traits::Transform::forward(x);
+
+				return (x >> (pass * Traits::PART_SIZE_BITS)) & PART_BITMASK;
+			};
+
+			std::fill(histograms.begin(), histograms.end(), 0);
+
+			for (size_t t = 0; t < num_threads; ++t)
+				pool.schedule([&, t]
+				{
+					CountType * counts = &histograms[t * HISTOGRAM_SIZE];
+					size_t end = std::min(size, (t + 1) * slice);
+					for (size_t i = t * slice; i < end; ++i)
+						++counts[get_part(ext::bit_cast<KeyBits>(Traits::extractKey(reader[i])))];
+				});
+			pool.wait();
+
+			size_t sum = 0;
+			for (size_t bucket = 0; bucket < HISTOGRAM_SIZE; ++bucket)
+			{
+				for (size_t t = 0; t < num_threads; ++t)
+				{
+					CountType tmp = histograms[t * HISTOGRAM_SIZE + bucket];
+					histograms[t * HISTOGRAM_SIZE + bucket] = sum;
+					sum += tmp;
+				}
+			}
+
+			for (size_t t = 0; t < num_threads; ++t)
+				pool.schedule([&, t]
+				{
+					CountType * offsets = &histograms[t * HISTOGRAM_SIZE];
+					size_t end = std::min(size, (t + 1) * slice);
+					for (size_t i = t * slice; i < end; ++i)
+						writer[offsets[get_part(ext::bit_cast<KeyBits>(Traits::extractKey(reader[i])))]++] = reader[i];
+				});
+			pool.wait();
+
+			std::swap(reader, writer);
+		}
+
+		if (!Traits::Transform::transform_is_simple)
+		{
+			for (size_t t = 0; t < num_threads; ++t)
+				pool.schedule([reader, size, slice, t]
+				{
+					size_t end = std::min(size, (t + 1) * slice);
+					for (size_t i = t * slice; i < end; ++i)
+						Traits::extractKey(reader[i]) = ext::bit_cast<typename Traits::Key>(
+							Traits::Transform::backward(ext::bit_cast<KeyBits>(Traits::extractKey(reader[i]))));
+				});
+			pool.wait();
+		}
+
+		/// If the number of passes is odd, the result resides in the temporary buffer.
+		if (reader != arr)
+			memcpy(arr, reader, size * sizeof(Element));
+	}
+}
+
 template <typename T>
 void ColumnVector<T>::getPermutation(bool reverse, size_t limit, Permutation & res) const
 {
 	size_t s = data.size();
 	res.resize(s);
-	for (size_t i = 0; i < s; ++i)
-		res[i] = i;
+
+#if COLUMN_VECTOR_RUNTIME_DISPATCH
+	if (haveAVX2())
+		permutationIotaImplAVX2(&res[0], s);
+	else
+#endif
+	{
+		for (size_t i = 0; i < s; ++i)
+			res[i] = i;
+	}
 
 	if (limit >= s)
 		limit = 0;
 
 	if (limit)
 	{
-		if (reverse)
+		if (limit < s / 16 && s <= std::numeric_limits<UInt32>::max())
+		{
+			/** For a limit much smaller than the column (ORDER BY ... LIMIT n),
+			  *  keep a bounded heap of the best `limit` (value, position) pairs:
+			  *  the data is streamed through sequentially once, O(N log limit)
+			  *  comparisons are done on the pairs themselves, and only `limit`
+			  *  elements stay resident instead of a heap over all N positions.
+			  */
+			struct PairCompare
+			{
+				bool reverse;
+				bool operator()(const ValueWithIndex<T> & a, const ValueWithIndex<T> & b) const
+				{
+					return reverse ? CompareHelper<T>::greater(a.value, b.value) : CompareHelper<T>::less(a.value, b.value);
+				}
+			};
+			PairCompare compare{reverse};
+
+			PaddedPODArray<ValueWithIndex<T>> heap(limit);
+			for (size_t i = 0; i < limit; ++i)
+				heap[i] = {data[i], static_cast<UInt32>(i)};
+
+			/// A max-heap by `compare`: the top is the worst of the kept elements.
+			std::make_heap(heap.begin(), heap.end(), compare);
+
+			for (size_t i = limit; i < s; ++i)
+			{
+				ValueWithIndex<T> candidate{data[i], static_cast<UInt32>(i)};
+				if (compare(candidate, heap.front()))
+				{
+					std::pop_heap(heap.begin(), heap.end(), compare);
+					heap[limit - 1] = candidate;
+					std::push_heap(heap.begin(), heap.end(), compare);
+				}
+			}
+
+			std::sort_heap(heap.begin(), heap.end(), compare);
+
+			/// The selected positions in order, then all the rest in any order.
+			PaddedPODArray<UInt8> is_selected(s, 0);
+			for (size_t i = 0; i < limit; ++i)
+			{
+				res[i] = heap[i].index;
+				is_selected[heap[i].index] = 1;
+			}
+
+			size_t out = limit;
+			for (size_t i = 0; i < s; ++i)
+				if (!is_selected[i])
+					res[out++] = i;
+		}
+		else if (reverse)
 			std::partial_sort(res.begin(), res.begin() + limit, res.end(), greater(*this));
 		else
 			std::partial_sort(res.begin(), res.begin() + limit, res.end(), less(*this));
 	}
 	else
 	{
-		if (reverse)
-			std::sort(res.begin(), res.end(), greater(*this));
+		/** For a full sort of a large enough column, LSD radix sort over (key, position) pairs
+		  *  is O(N) and accesses memory sequentially, in contrast to std::sort with an indirect
+		  *  comparator, that does a random read of `data` on every comparison.
+		  * With canonicalized keys, the float transform in RadixSort puts NaNs after all
+		  *  normal numbers - same as the `less` comparator; but after reversing the result
+		  *  they would be in the beginning, so for descending sort of floats we keep the
+		  *  comparison sort.
+		  */
+		if (s >= 256 && s <= std::numeric_limits<UInt32>::max()
+			&& !(reverse && std::is_floating_point<T>::value))
+		{
+			PaddedPODArray<ValueWithIndex<T>> pairs(s);
+			for (size_t i = 0; i < s; ++i)
+				pairs[i] = {canonicalSortKey(data[i]), static_cast<UInt32>(i)};
+
+			/// Above this size, the sort takes long enough for the per-pass synchronization to pay off.
+			static constexpr size_t PARALLEL_RADIX_SORT_THRESHOLD = 1 << 18;
+
+			size_t num_threads = 1;
+			if (s >= PARALLEL_RADIX_SORT_THRESHOLD)
+				num_threads = std::min<size_t>(getNumberOfPhysicalCPUCores(), s / (PARALLEL_RADIX_SORT_THRESHOLD / 4));
+
+			if (num_threads > 1)
+				parallelRadixSort<PermutationRadixSortTraits<T>>(&pairs[0], s, num_threads);
+			else
+				RadixSort<PermutationRadixSortTraits<T>>::execute(&pairs[0], s);
+
+			if (reverse)
+			{
+				for (size_t i = 0; i < s; ++i)
+					res[i] = pairs[s - 1 - i].index;
+			}
+			else
+			{
+				for (size_t i = 0; i < s; ++i)
+					res[i] = pairs[i].index;
+			}
+		}
+		else if (s <= std::numeric_limits<UInt32>::max())
+		{
+			/** Even when the radix sort does not apply, it pays off to sort (value, position)
+			  *  pairs rather than bare positions: each comparison then reads the values
+			  *  from the buffer being sorted instead of doing a random read of `data`.
+			  */
+			if (std::is_floating_point<T>::value && !reverse)
+			{
+				/** For ascending floats, sort the same bit-transformed canonicalized keys as
+				  *  the radix sort does: the transform linearizes the float order into the
+				  *  unsigned integer order (NaNs after all normal numbers), so the comparator
+				  *  becomes a single integer compare without the NaN branch of
+				  *  FloatCompareHelper on every comparison.
+				  * For descending floats this does not apply - see the comment above.
+				  * For integers CompareHelper::less already inlines to a plain compare.
+				  */
+				using KeyBits = typename PermutationRadixSortKeyBits<T>::Type;
+				using Transform = RadixSortFloatTransform<KeyBits>;
+
+				PaddedPODArray<ValueWithIndex<KeyBits>> pairs(s);
+				for (size_t i = 0; i < s; ++i)
+					pairs[i] = {Transform::forward(ext::bit_cast<KeyBits>(canonicalSortKey(data[i]))), static_cast<UInt32>(i)};
+
+				blockQuickSort(pairs.begin(), pairs.end(),
+					[](const ValueWithIndex<KeyBits> & a, const ValueWithIndex<KeyBits> & b) { return a.value < b.value; });
+
+				for (size_t i = 0; i < s; ++i)
+					res[i] = pairs[i].index;
+			}
+			else
+			{
+				PaddedPODArray<ValueWithIndex<T>> pairs(s);
+				for (size_t i = 0; i < s; ++i)
+					pairs[i] = {data[i], static_cast<UInt32>(i)};
+
+				if (reverse)
+					blockQuickSort(pairs.begin(), pairs.end(),
+						[](const ValueWithIndex<T> & a, const ValueWithIndex<T> & b) { return CompareHelper<T>::greater(a.value, b.value); });
+				else
+					blockQuickSort(pairs.begin(), pairs.end(),
+						[](const ValueWithIndex<T> & a, const ValueWithIndex<T> & b) { return CompareHelper<T>::less(a.value, b.value); });
+
+				for (size_t i = 0; i < s; ++i)
+					res[i] = pairs[i].index;
+			}
+		}
 		else
-			std::sort(res.begin(), res.end(), less(*this));
+		{
+			/// Positions do not fit in UInt32 - sort them through the indirect comparator.
+			if (reverse)
+				blockQuickSort(res.begin(), res.end(), greater(*this));
+			else
+				blockQuickSort(res.begin(), res.end(), less(*this));
+		}
 	}
 }
 
@@ -98,6 +510,38 @@ std::string ColumnVector<T>::getName() const
 	return "ColumnVector<" + TypeName<T>::get() + ">";
 }
 
+#if __SSE2__
+
+namespace
+{
+	/** For copies much larger than the last level cache, ordinary stores first read
+	  *  the destination cache lines only to overwrite them entirely (write-allocate).
+	  * Non-temporal stores bypass the cache and save that read - about a third
+	  *  of the memory traffic. They only make sense when the destination will not
+	  *  fit in cache anyway, so the threshold is a multiple of a typical LLC size.
+	  */
+	constexpr size_t NON_TEMPORAL_COPY_THRESHOLD = 16 * 1024 * 1024;
+
+	void memcpyNonTemporal(char * dst, const char * src, size_t bytes)
+	{
+		/// Stream stores require an aligned destination; copy the unaligned head as usual.
+		size_t head = (-reinterpret_cast<intptr_t>(dst)) & 15;
+		memcpy(dst, src, head);
+		dst += head;
+		src += head;
+		bytes -= head;
+
+		size_t streamed_bytes = bytes / 16 * 16;
+		for (size_t i = 0; i < streamed_bytes; i += 16)
+			_mm_stream_si128(reinterpret_cast<__m128i *>(dst + i), _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)));
+		_mm_sfence();
+
+		memcpy(dst + streamed_bytes, src + streamed_bytes, bytes - streamed_bytes);
+	}
+}
+
+#endif
+
 template <typename T>
 ColumnPtr ColumnVector<T>::cloneResized(size_t size) const
 {
@@ -109,6 +553,13 @@ ColumnPtr ColumnVector<T>::cloneResized(size_t size) const
 		new_col.data.resize(size);
 
 		size_t count = std::min(this->size(), size);
+
+#if __SSE2__
+		if (count * sizeof(data[0]) >= NON_TEMPORAL_COPY_THRESHOLD)
+			memcpyNonTemporal(reinterpret_cast<char *>(&new_col.data[0]),
+				reinterpret_cast<const char *>(&data[0]), count * sizeof(data[0]));
+		else
+#endif
 		memcpy(&new_col.data[0], &data[0], count * sizeof(data[0]));
 
 		if (size > count)
@@ -138,9 +589,184 @@ void ColumnVector<T>::insertRangeFrom(const IColumn & src, size_t start, size_t
 
 	size_t old_size = data.size();
 	data.resize(old_size + length);
+
+#if __SSE2__
+	if (length * sizeof(data[0]) >= NON_TEMPORAL_COPY_THRESHOLD)
+		memcpyNonTemporal(reinterpret_cast<char *>(&data[old_size]),
+			reinterpret_cast<const char *>(&src_vec.data[start]), length * sizeof(data[0]));
+	else
+#endif
 	memcpy(&data[old_size], &src_vec.data[start], length * sizeof(data[0]));
 }
 
+#if COLUMN_VECTOR_RUNTIME_DISPATCH
+
+#if !(__AVX512F__ && __AVX512VL__ && __AVX512BW__)
+	#pragma GCC push_options
+	#pragma GCC target("avx512f,avx512bw,avx512vl")
+	#define COLUMN_VECTOR_POP_TARGET
+#endif
+
+namespace
+{
+	/** For 32 and 64-bit elements, the whole mask-then-gather sequence collapses
+	  *  to a compressed store: one VPCOMPRESS per 16 values, no branches on selectivity.
+	  * The result is overcommitted to the maximal possible size upfront
+	  *  (PODArray does not initialize elements, so this is just a capacity check)
+	  *  and shrunk to the actual size after the loop.
+	  * Only instantiated for sizeof(T) of 4 and 8 - checked by the caller.
+	  */
+	template <typename T>
+	void filterImplAVX512(const UInt8 *& filt_pos, const UInt8 * filt_end, const T *& data_pos, PaddedPODArray<T> & res_data)
+	{
+		static constexpr size_t AVX512_BYTES = 16;
+		const UInt8 * filt_end_avx512 = filt_pos + (filt_end - filt_pos) / AVX512_BYTES * AVX512_BYTES;
+
+		size_t old_size = res_data.size();
+		res_data.resize(old_size + (filt_end - filt_pos));
+		T * out = &res_data[old_size];
+
+		while (filt_pos < filt_end_avx512)
+		{
+			__mmask16 mask = _mm_cmpgt_epi8_mask(_mm_loadu_si128(reinterpret_cast<const __m128i *>(filt_pos)), _mm_setzero_si128());
+
+			if (sizeof(T) == 4)
+			{
+				_mm512_mask_compressstoreu_ps(reinterpret_cast<float *>(out), mask,
+					_mm512_loadu_ps(reinterpret_cast<const float *>(data_pos)));
+			}
+			else
+			{
+				_mm512_mask_compressstoreu_pd(reinterpret_cast<double *>(out), __mmask8(mask),
+					_mm512_loadu_pd(reinterpret_cast<const double *>(data_pos)));
+				_mm512_mask_compressstoreu_pd(reinterpret_cast<double *>(out) + __builtin_popcount(mask & 0xFF), __mmask8(mask >> 8),
+					_mm512_loadu_pd(reinterpret_cast<const double *>(data_pos) + 8));
+			}
+
+			out += __builtin_popcount(mask);
+			filt_pos += AVX512_BYTES;
+			data_pos += AVX512_BYTES;
+		}
+
+		res_data.resize(out - &res_data[0]);
+	}
+}
+
+#ifdef COLUMN_VECTOR_POP_TARGET
+	#pragma GCC pop_options
+	#undef COLUMN_VECTOR_POP_TARGET
+#endif
+
+#if !__AVX2__
+	#pragma GCC push_options
+	#pragma GCC target("avx2")
+	#define COLUMN_VECTOR_POP_TARGET
+#endif
+
+namespace
+{
+	/** Same idea as in the SSE2 branch of `filter`, but with 32 values per iteration.
+	  * On long runs that entirely pass or do not pass the filter,
+	  *  twice less iterations and mask probes are needed.
+	  */
+	template <typename T>
+	void filterImplAVX2(const UInt8 *& filt_pos, const UInt8 * filt_end, const T *& data_pos, PaddedPODArray<T> & res_data)
+	{
+		static constexpr size_t AVX2_BYTES = 32;
+		const __m256i zero32 = _mm256_setzero_si256();
+		const UInt8 * filt_end_avx2 = filt_pos + (filt_end - filt_pos) / AVX2_BYTES * AVX2_BYTES;
+
+		/** Consecutive fully-passing pieces are accumulated into one range,
+		  *  to insert them with one capacity check and one large memcpy.
+		  */
+		const T * passed_run_begin = nullptr;
+
+		while (filt_pos < filt_end_avx2)
+		{
+			/// Prefetching beyond the end is harmless.
+			__builtin_prefetch(filt_pos + 64);
+			__builtin_prefetch(data_pos + 64);
+
+			UInt32 mask = _mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(filt_pos)), zero32));
+
+			if (0xFFFFFFFF == mask)
+			{
+				if (!passed_run_begin)
+					passed_run_begin = data_pos;
+			}
+			else
+			{
+				if (passed_run_begin)
+				{
+					res_data.insert(passed_run_begin, data_pos);
+					passed_run_begin = nullptr;
+				}
+
+				if (mask)
+				{
+					/// Iterate only over set bits of the mask: popcount(mask) iterations instead of 32 data-dependent branches.
+					size_t num_passed = __builtin_popcount(mask);
+					T * out = res_data.reserve_and_get_tail(num_passed);
+
+					while (mask)
+					{
+						size_t index = __builtin_ctz(mask);
+						*out++ = data_pos[index];
+						mask &= mask - 1;
+					}
+
+					res_data.commit(num_passed);
+				}
+			}
+
+			filt_pos += AVX2_BYTES;
+			data_pos += AVX2_BYTES;
+		}
+
+		if (passed_run_begin)
+			res_data.insert(passed_run_begin, data_pos);
+	}
+
+	/** For 32 and 64-bit elements, use gather instructions: they issue several
+	  *  independent indexed loads per instruction, so cache-miss latencies
+	  *  overlap across lanes instead of being serialized.
+	  * Permutation indices are 64-bit, so 4 values are gathered per iteration.
+	  * Only instantiated for sizeof(T) of 4 and 8 - checked by the caller.
+	  */
+	template <typename T>
+	void permuteImplAVX2(const T * data, const size_t * perm, T * out, size_t limit)
+	{
+		size_t i = 0;
+		static constexpr size_t values_per_iteration = sizeof(__m256i) / sizeof(size_t);
+
+		for (; i + values_per_iteration <= limit; i += values_per_iteration)
+		{
+			__m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&perm[i]));
+
+			if (sizeof(T) == 4)
+			{
+				__m128i v = _mm256_i64gather_epi32(reinterpret_cast<const int *>(data), index, 4);
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(&out[i]), v);
+			}
+			else
+			{
+				__m256i v = _mm256_i64gather_epi64(reinterpret_cast<const long long *>(data), index, 8);
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(&out[i]), v);
+			}
+		}
+
+		for (; i < limit; ++i)
+			out[i] = data[perm[i]];
+	}
+}
+
+#ifdef COLUMN_VECTOR_POP_TARGET
+	#pragma GCC pop_options
+	#undef COLUMN_VECTOR_POP_TARGET
+#endif
+
+#endif
+
 template <typename T>
 ColumnPtr ColumnVector<T>::filter(const IColumn::Filter & filt, ssize_t result_size_hint) const
 {
@@ -151,13 +777,48 @@ ColumnPtr ColumnVector<T>::filter(const IColumn::Filter & filt, ssize_t result_s
 	std::shared_ptr<Self> res = std::make_shared<Self>();
 	typename Self::Container_t & res_data = res->getData();
 
-	if (result_size_hint)
+	/** Allocation strategy:
+	  * - when the AVX-512 kernel below will run, nothing is reserved: that kernel
+	  *   overcommits the result to the maximal possible size itself and shrinks it
+	  *   afterwards, so any reserve (and especially the counting prepass) is wasted work;
+	  * - a positive hint is trusted and reserved as is (hint == size means "everything passes");
+	  * - a negative hint means "presumably a lot" - reserve for the whole column;
+	  * - with no hint, count the exact result size with a cheap pass over the filter
+	  *   (one byte per row, SIMD + popcount) and allocate once, instead of growing
+	  *   geometrically with reallocation-copies. For small columns the prepass costs
+	  *   more than the reallocations it saves - let the array grow as usual.
+	  * Almost fully-passing filters need no separate mode: the SIMD loops below
+	  *  turn runs of fully-set mask blocks into single large inserts anyway.
+	  */
+	static constexpr size_t FILTER_PREPASS_THRESHOLD = 4096;
+
+#if COLUMN_VECTOR_RUNTIME_DISPATCH
+	const bool will_overcommit = (sizeof(T) == 4 || sizeof(T) == 8) && haveAVX512();
+#else
+	static constexpr bool will_overcommit = false;
+#endif
+
+	if (will_overcommit)
+	{
+		/// The AVX-512 kernel allocates for itself.
+	}
+	else if (result_size_hint)
 		res_data.reserve(result_size_hint > 0 ? result_size_hint : size);
+	else if (size >= FILTER_PREPASS_THRESHOLD)
+		res_data.reserve(countBytesInFilter(filt));
 
 	const UInt8 * filt_pos = &filt[0];
 	const UInt8 * filt_end = filt_pos + size;
 	const T * data_pos = &data[0];
 
+#if COLUMN_VECTOR_RUNTIME_DISPATCH
+	if (will_overcommit)
+		filterImplAVX512(filt_pos, filt_end, data_pos, res_data);
+
+	if (haveAVX2())
+		filterImplAVX2(filt_pos, filt_end, data_pos, res_data);
+#endif
+
 #if __SSE2__
 	/** A slightly more optimized version.
 		* Based on the assumption that often pieces of consecutive values
@@ -167,39 +828,68 @@ ColumnPtr ColumnVector<T>::filter(const IColumn::Filter & filt, ssize_t result_s
 
 	static constexpr size_t SIMD_BYTES = 16;
 	const __m128i zero16 = _mm_setzero_si128();
-	const UInt8 * filt_end_sse = filt_pos + size / SIMD_BYTES * SIMD_BYTES;
+	const UInt8 * filt_end_sse = filt_pos + (filt_end - filt_pos) / SIMD_BYTES * SIMD_BYTES;
+
+	const T * passed_run_begin_sse = nullptr;
 
 	while (filt_pos < filt_end_sse)
 	{
 		int mask = _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(filt_pos)), zero16));
 
-		if (0 == mask)
-		{
-			/// Nothing is inserted.
-		}
-		else if (0xFFFF == mask)
+		if (0xFFFF == mask)
 		{
-			res_data.insert(data_pos, data_pos + SIMD_BYTES);
+			if (!passed_run_begin_sse)
+				passed_run_begin_sse = data_pos;
 		}
 		else
 		{
-			for (size_t i = 0; i < SIMD_BYTES; ++i)
-				if (filt_pos[i])
-					res_data.push_back(data_pos[i]);
+			if (passed_run_begin_sse)
+			{
+				res_data.insert(passed_run_begin_sse, data_pos);
+				passed_run_begin_sse = nullptr;
+			}
+
+			if (mask)
+			{
+				/// Iterate only over set bits of the mask - the same way as in the AVX2 branch above.
+				size_t num_passed = __builtin_popcount(mask);
+				T * out = res_data.reserve_and_get_tail(num_passed);
+
+				while (mask)
+				{
+					size_t index = __builtin_ctz(mask);
+					*out++ = data_pos[index];
+					mask &= mask - 1;
+				}
+
+				res_data.commit(num_passed);
+			}
 		}
 
 		filt_pos += SIMD_BYTES;
 		data_pos += SIMD_BYTES;
 	}
+
+	if (passed_run_begin_sse)
+		res_data.insert(passed_run_begin_sse, data_pos);
 #endif
 
-	while (filt_pos < filt_end)
+	if (filt_pos < filt_end)
 	{
-		if (*filt_pos)
-			res_data.push_back(*data_pos);
+		/// Single capacity check for the whole tail instead of one per push_back.
+		T * out = res_data.reserve_and_get_tail(filt_end - filt_pos);
+		size_t num_passed = 0;
 
-		++filt_pos;
-		++data_pos;
+		while (filt_pos < filt_end)
+		{
+			if (*filt_pos)
+				out[num_passed++] = *data_pos;
+
+			++filt_pos;
+			++data_pos;
+		}
+
+		res_data.commit(num_passed);
 	}
 
 	return res;
@@ -220,8 +910,26 @@ ColumnPtr ColumnVector<T>::permute(const IColumn::Permutation & perm, size_t lim
 
 	std::shared_ptr<Self> res = std::make_shared<Self>(limit);
 	typename Self::Container_t & res_data = res->getData();
-	for (size_t i = 0; i < limit; ++i)
-		res_data[i] = data[perm[i]];
+
+#if COLUMN_VECTOR_RUNTIME_DISPATCH
+	if ((sizeof(T) == 4 || sizeof(T) == 8) && haveAVX2())
+		permuteImplAVX2(&data[0], &perm[0], &res_data[0], limit);
+	else
+#endif
+	{
+		/** Indexed loads miss the cache on random permutations. Prefetching a fixed
+		  *  distance ahead overlaps the miss latency with the copying of previous values.
+		  */
+		static constexpr size_t prefetch_distance = 16;
+
+		for (size_t i = 0; i < limit; ++i)
+		{
+			if (i + prefetch_distance < limit)
+				__builtin_prefetch(&data[perm[i + prefetch_distance]]);
+
+			res_data[i] = data[perm[i]];
+		}
+	}
 
 	return res;
 }
@@ -238,7 +946,13 @@ ColumnPtr ColumnVector<T>::replicate(const IColumn::Offsets_t & offsets) const
 
 	std::shared_ptr<Self> res = std::make_shared<Self>();
 	typename Self::Container_t & res_data = res->getData();
-	res_data.reserve(offsets.back());
+	res_data.resize(offsets.back());
+
+	/** The result size is known in advance, so write through a raw pointer:
+	  *  a run of equal values becomes one memset/fill instead of a push_back
+	  *  with a capacity check per element.
+	  */
+	T * out = &res_data[0];
 
 	IColumn::Offset_t prev_offset = 0;
 	for (size_t i = 0; i < size; ++i)
@@ -246,13 +960,299 @@ ColumnPtr ColumnVector<T>::replicate(const IColumn::Offsets_t & offsets) const
 		size_t size_to_replicate = offsets[i] - prev_offset;
 		prev_offset = offsets[i];
 
-		for (size_t j = 0; j < size_to_replicate; ++j)
-			res_data.push_back(data[i]);
+		if (sizeof(T) == 1)
+			memset(out, data[i], size_to_replicate);
+		else
+			std::fill_n(out, size_to_replicate, data[i]);
+
+		out += size_to_replicate;
 	}
 
 	return res;
 }
 
+#if COLUMN_VECTOR_RUNTIME_DISPATCH
+
+#if !__AVX2__
+	#pragma GCC push_options
+	#pragma GCC target("avx2")
+	#define COLUMN_VECTOR_POP_TARGET
+#endif
+
+namespace
+{
+	/// 256-bit min/max for each element type. 64-bit integers have no dedicated instructions - compare and blend.
+	template <typename T> struct SimdMinMax;
+
+	template <> struct SimdMinMax<UInt8>
+	{
+		static __m256i min(__m256i a, __m256i b) { return _mm256_min_epu8(a, b); }
+		static __m256i max(__m256i a, __m256i b) { return _mm256_max_epu8(a, b); }
+	};
+
+	template <> struct SimdMinMax<Int8>
+	{
+		static __m256i min(__m256i a, __m256i b) { return _mm256_min_epi8(a, b); }
+		static __m256i max(__m256i a, __m256i b) { return _mm256_max_epi8(a, b); }
+	};
+
+	template <> struct SimdMinMax<UInt16>
+	{
+		static __m256i min(__m256i a, __m256i b) { return _mm256_min_epu16(a, b); }
+		static __m256i max(__m256i a, __m256i b) { return _mm256_max_epu16(a, b); }
+	};
+
+	template <> struct SimdMinMax<Int16>
+	{
+		static __m256i min(__m256i a, __m256i b) { return _mm256_min_epi16(a, b); }
+		static __m256i max(__m256i a, __m256i b) { return _mm256_max_epi16(a, b); }
+	};
+
+	template <> struct SimdMinMax<UInt32>
+	{
+		static __m256i min(__m256i a, __m256i b) { return _mm256_min_epu32(a, b); }
+		static __m256i max(__m256i a, __m256i b) { return _mm256_max_epu32(a, b); }
+	};
+
+	template <> struct SimdMinMax<Int32>
+	{
+		static __m256i min(__m256i a, __m256i b) { return _mm256_min_epi32(a, b); }
+		static __m256i max(__m256i a, __m256i b) { return _mm256_max_epi32(a, b); }
+	};
+
+	template <> struct SimdMinMax<Int64>
+	{
+		static __m256i min(__m256i a, __m256i b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+		static __m256i max(__m256i a, __m256i b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+	};
+
+	template <> struct SimdMinMax<UInt64>
+	{
+		/// Only a signed comparison is available - flip the sign bits of both operands.
+		static __m256i flip(__m256i x) { return _mm256_xor_si256(x, _mm256_set1_epi64x(0x8000000000000000LL)); }
+
+		static __m256i min(__m256i a, __m256i b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(flip(a), flip(b))); }
+		static __m256i max(__m256i a, __m256i b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(flip(a), flip(b))); }
+	};
+
+	/** Vectorized part of getExtremes. Advances `pos` past the processed prefix,
+	  *  the tail is left for the scalar loop of the caller.
+	  * Integers contain no NaNs, so a plain min/max over lanes is enough.
+	  */
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value, void>::type
+	updateExtremesSIMD(const T *& pos, const T * end, T & cur_min, T & cur_max, bool & has_value)
+	{
+		static constexpr size_t lanes = sizeof(__m256i) / sizeof(T);
+		if (static_cast<size_t>(end - pos) < lanes)
+			return;
+
+		__m256i vmin = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pos));
+		__m256i vmax = vmin;
+		pos += lanes;
+
+		while (static_cast<size_t>(end - pos) >= lanes)
+		{
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pos));
+			vmin = SimdMinMax<T>::min(vmin, v);
+			vmax = SimdMinMax<T>::max(vmax, v);
+			pos += lanes;
+		}
+
+		T mins[lanes];
+		T maxs[lanes];
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(mins), vmin);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(maxs), vmax);
+
+		cur_min = mins[0];
+		cur_max = maxs[0];
+		for (size_t i = 1; i < lanes; ++i)
+		{
+			if (mins[i] < cur_min)
+				cur_min = mins[i];
+			if (maxs[i] > cur_max)
+				cur_max = maxs[i];
+		}
+		has_value = true;
+	}
+
+	inline Float32 horizontalMin(__m256 v)
+	{
+		__m128 x = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+		x = _mm_min_ps(x, _mm_movehl_ps(x, x));
+		x = _mm_min_ss(x, _mm_shuffle_ps(x, x, 1));
+		return _mm_cvtss_f32(x);
+	}
+
+	inline Float32 horizontalMax(__m256 v)
+	{
+		__m128 x = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+		x = _mm_max_ps(x, _mm_movehl_ps(x, x));
+		x = _mm_max_ss(x, _mm_shuffle_ps(x, x, 1));
+		return _mm_cvtss_f32(x);
+	}
+
+	inline Float64 horizontalMin(__m256d v)
+	{
+		__m128d x = _mm_min_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+		x = _mm_min_sd(x, _mm_unpackhi_pd(x, x));
+		return _mm_cvtsd_f64(x);
+	}
+
+	inline Float64 horizontalMax(__m256d v)
+	{
+		__m128d x = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+		x = _mm_max_sd(x, _mm_unpackhi_pd(x, x));
+		return _mm_cvtsd_f64(x);
+	}
+
+	/** Floats may contain NaNs, that must be skipped.
+	  * Columns with NaNs are rare, so first make a cheap scan for them (one
+	  *  self-comparison per vector, exiting at the first hit). In the common
+	  *  NaN-free case, the reduction is then a plain min/max without masking.
+	  * Intel min/max return the second operand for NaN, so in the presence of
+	  *  NaNs the lanes are first replaced with the neutral element
+	  *  (+-infinity) using the "ordered" mask. If no ordered value was seen
+	  *  at all, the accumulators are left untouched and the result stays NaN,
+	  *  same as in the scalar loop.
+	  */
+	inline bool containsNaN(const Float32 * pos, const Float32 * end)
+	{
+		for (; pos < end; pos += sizeof(__m256) / sizeof(Float32))
+		{
+			__m256 v = _mm256_loadu_ps(pos);
+			if (_mm256_movemask_ps(_mm256_cmp_ps(v, v, _CMP_UNORD_Q)))
+				return true;
+		}
+		return false;
+	}
+
+	inline bool containsNaN(const Float64 * pos, const Float64 * end)
+	{
+		for (; pos < end; pos += sizeof(__m256d) / sizeof(Float64))
+		{
+			__m256d v = _mm256_loadu_pd(pos);
+			if (_mm256_movemask_pd(_mm256_cmp_pd(v, v, _CMP_UNORD_Q)))
+				return true;
+		}
+		return false;
+	}
+
+	inline void updateExtremesSIMD(const Float32 *& pos, const Float32 * end, Float32 & cur_min, Float32 & cur_max, bool & has_value)
+	{
+		static constexpr size_t lanes = sizeof(__m256) / sizeof(Float32);
+		if (static_cast<size_t>(end - pos) < lanes)
+			return;
+
+		const Float32 * vec_end = pos + (end - pos) / lanes * lanes;
+
+		if (!containsNaN(pos, vec_end))
+		{
+			__m256 vmin = _mm256_loadu_ps(pos);
+			__m256 vmax = vmin;
+			pos += lanes;
+
+			while (pos < vec_end)
+			{
+				__m256 v = _mm256_loadu_ps(pos);
+				vmin = _mm256_min_ps(vmin, v);
+				vmax = _mm256_max_ps(vmax, v);
+				pos += lanes;
+			}
+
+			cur_min = horizontalMin(vmin);
+			cur_max = horizontalMax(vmax);
+			has_value = true;
+			return;
+		}
+
+		const __m256 plus_inf = _mm256_set1_ps(std::numeric_limits<Float32>::infinity());
+		const __m256 minus_inf = _mm256_set1_ps(-std::numeric_limits<Float32>::infinity());
+
+		__m256 vmin = plus_inf;
+		__m256 vmax = minus_inf;
+		__m256 any_ordered = _mm256_setzero_ps();
+
+		while (pos < vec_end)
+		{
+			__m256 v = _mm256_loadu_ps(pos);
+			__m256 ordered = _mm256_cmp_ps(v, v, _CMP_ORD_Q);
+			any_ordered = _mm256_or_ps(any_ordered, ordered);
+			vmin = _mm256_min_ps(vmin, _mm256_blendv_ps(plus_inf, v, ordered));
+			vmax = _mm256_max_ps(vmax, _mm256_blendv_ps(minus_inf, v, ordered));
+			pos += lanes;
+		}
+
+		if (_mm256_movemask_ps(any_ordered))
+		{
+			/// Lanes that saw only NaNs hold +-infinity and cannot win unless real infinities are present.
+			cur_min = horizontalMin(vmin);
+			cur_max = horizontalMax(vmax);
+			has_value = true;
+		}
+	}
+
+	inline void updateExtremesSIMD(const Float64 *& pos, const Float64 * end, Float64 & cur_min, Float64 & cur_max, bool & has_value)
+	{
+		static constexpr size_t lanes = sizeof(__m256d) / sizeof(Float64);
+		if (static_cast<size_t>(end - pos) < lanes)
+			return;
+
+		const Float64 * vec_end = pos + (end - pos) / lanes * lanes;
+
+		if (!containsNaN(pos, vec_end))
+		{
+			__m256d vmin = _mm256_loadu_pd(pos);
+			__m256d vmax = vmin;
+			pos += lanes;
+
+			while (pos < vec_end)
+			{
+				__m256d v = _mm256_loadu_pd(pos);
+				vmin = _mm256_min_pd(vmin, v);
+				vmax = _mm256_max_pd(vmax, v);
+				pos += lanes;
+			}
+
+			cur_min = horizontalMin(vmin);
+			cur_max = horizontalMax(vmax);
+			has_value = true;
+			return;
+		}
+
+		const __m256d plus_inf = _mm256_set1_pd(std::numeric_limits<Float64>::infinity());
+		const __m256d minus_inf = _mm256_set1_pd(-std::numeric_limits<Float64>::infinity());
+
+		__m256d vmin = plus_inf;
+		__m256d vmax = minus_inf;
+		__m256d any_ordered = _mm256_setzero_pd();
+
+		while (pos < vec_end)
+		{
+			__m256d v = _mm256_loadu_pd(pos);
+			__m256d ordered = _mm256_cmp_pd(v, v, _CMP_ORD_Q);
+			any_ordered = _mm256_or_pd(any_ordered, ordered);
+			vmin = _mm256_min_pd(vmin, _mm256_blendv_pd(plus_inf, v, ordered));
+			vmax = _mm256_max_pd(vmax, _mm256_blendv_pd(minus_inf, v, ordered));
+			pos += lanes;
+		}
+
+		if (_mm256_movemask_pd(any_ordered))
+		{
+			cur_min = horizontalMin(vmin);
+			cur_max = horizontalMax(vmax);
+			has_value = true;
+		}
+	}
+}
+
+#ifdef COLUMN_VECTOR_POP_TARGET
+	#pragma GCC pop_options
+	#undef COLUMN_VECTOR_POP_TARGET
+#endif
+
+#endif
+
 template <typename T>
 void ColumnVector<T>::getExtremes(Field & min, Field & max) const
 {
@@ -276,8 +1276,18 @@ void ColumnVector<T>::getExtremes(Field & min, Field & max) const
 	T cur_min = NaNOrZero<T>();
 	T cur_max = NaNOrZero<T>();
 
-	for (const T x : data)
+	const T * pos = &data[0];
+	const T * end = pos + size;
+
+#if COLUMN_VECTOR_RUNTIME_DISPATCH
+	if (haveAVX2())
+		updateExtremesSIMD(pos, end, cur_min, cur_max, has_value);
+#endif
+
+	for (; pos < end; ++pos)
 	{
+		const T x = *pos;
+
 		if (isNaN(x))
 			continue;
 
@@ -0,0 +1,147 @@
+#include <DB/Common/BlockQuickSort.h>
+#include <DB/Common/Stopwatch.h>
+#include <DB/IO/ReadHelpers.h>
+#include <DB/Core/Defines.h>
+#include <DB/Core/Types.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace DB;
+
+/** Without arguments - a randomized correctness test of blockQuickSort against std::sort.
+  * With arguments `n method` - a benchmark: method 1 - std::sort, method 2 - blockQuickSort.
+  */
+
+static std::mt19937_64 rng(12345);
+
+
+template <typename T, typename Compare>
+static bool checkOne(std::vector<T> data, Compare less, const char * name)
+{
+	std::vector<T> expected = data;
+	blockQuickSort(data.begin(), data.end(), less);
+	std::sort(expected.begin(), expected.end(), less);
+
+	/// The sort is not stable - compare the ordering, not the elements themselves.
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		if (less(data[i], expected[i]) || less(expected[i], data[i]))
+		{
+			std::cerr << "Fail: " << name << ", size " << data.size() << ", position " << i << "\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool testCorrectness()
+{
+	bool res = true;
+
+	for (size_t size : {0, 1, 2, 3, 23, 24, 25, 127, 128, 129, 255, 256, 257, 10000, 1000000})
+	{
+		std::vector<UInt64> random_data(size);
+		for (auto & x : random_data)
+			x = rng();
+		res &= checkOne(random_data, [](UInt64 a, UInt64 b) { return a < b; }, "random");
+		res &= checkOne(random_data, [](UInt64 a, UInt64 b) { return a > b; }, "random, descending");
+
+		std::vector<UInt64> sorted_data = random_data;
+		std::sort(sorted_data.begin(), sorted_data.end());
+		res &= checkOne(sorted_data, [](UInt64 a, UInt64 b) { return a < b; }, "sorted");
+
+		std::reverse(sorted_data.begin(), sorted_data.end());
+		res &= checkOne(sorted_data, [](UInt64 a, UInt64 b) { return a < b; }, "reversed");
+
+		std::vector<UInt64> constant_data(size, 42);
+		res &= checkOne(constant_data, [](UInt64 a, UInt64 b) { return a < b; }, "constant");
+
+		/// Many duplicates - the case where a one-sided partition degrades to quadratic time.
+		std::vector<UInt64> dup_data(size);
+		for (auto & x : dup_data)
+			x = rng() % 4;
+		res &= checkOne(dup_data, [](UInt64 a, UInt64 b) { return a < b; }, "duplicates");
+
+		/// Floats with NaNs under a NaN-aware comparator (NaNs are put last, as in ColumnVector).
+		std::vector<Float64> float_data(size);
+		for (auto & x : float_data)
+			x = rng() % 16 == 0 ? NAN : (static_cast<Float64>(static_cast<Int64>(rng())) / 1000);
+		res &= checkOne(float_data, [](Float64 a, Float64 b)
+		{
+			if (std::isnan(b))
+				return !std::isnan(a);
+			return a < b;
+		}, "floats with NaNs");
+
+		/// (key, position) pairs, as sorted in ColumnVector::getPermutation.
+		struct Pair { UInt64 key; UInt32 index; };
+		std::vector<Pair> pairs(size);
+		for (size_t i = 0; i < size; ++i)
+			pairs[i] = {rng() % 1000, static_cast<UInt32>(i)};
+		res &= checkOne(pairs, [](const Pair & a, const Pair & b) { return a.key < b.key; }, "pairs");
+	}
+
+	std::cerr << (res ? "Ok." : "Fail!") << std::endl;
+	return res;
+}
+
+
+using Key = UInt64;
+
+static void NO_INLINE sort1(Key * data, size_t size)
+{
+	std::sort(data, data + size);
+}
+
+static void NO_INLINE sort2(Key * data, size_t size)
+{
+	blockQuickSort(data, data + size);
+}
+
+
+int main(int argc, char ** argv)
+{
+	if (argc < 3)
+		return testCorrectness() ? 0 : 1;
+
+	size_t n = DB::parse<size_t>(argv[1]);
+	size_t method = DB::parse<size_t>(argv[2]);
+
+	std::vector<Key> data(n);
+	for (auto & elem : data)
+		elem = rng();
+
+	{
+		Stopwatch watch;
+
+		if (method == 1)	sort1(&data[0], n);
+		if (method == 2)	sort2(&data[0], n);
+
+		watch.stop();
+		double elapsed = watch.elapsedSeconds();
+		std::cerr
+			<< "Sorted in " << elapsed
+			<< " (" << n / elapsed << " elem/sec., "
+			<< n * sizeof(Key) / elapsed / 1048576 << " MB/sec.)"
+			<< std::endl;
+	}
+
+	{
+		size_t i = 1;
+		while (i < n)
+		{
+			if (!(data[i - 1] <= data[i]))
+				break;
+			++i;
+		}
+
+		std::cerr << "Result: " << (i == n ? "Ok." : "Fail!") << std::endl;
+	}
+
+	return 0;
+}
@@ -442,6 +442,68 @@ void test3()
 		std::cerr << "Some errors were found in test 3\n";
 }
 
+void test4()
+{
+	using namespace DB;
+
+	bool res = true;
+
+	{
+		PaddedPODArray<UInt64> arr;
+
+		arr.push_back(1);
+		arr.push_back(2);
+
+		/// Reserve space for more elements than are actually written.
+		UInt64 * tail = arr.reserve_and_get_tail(3);
+		tail[0] = 3;
+		tail[1] = 4;
+		arr.commit(2);
+
+		ASSERT_CHECK((arr.size() == 4), res);
+		ASSERT_CHECK((arr[0] == 1), res);
+		ASSERT_CHECK((arr[1] == 2), res);
+		ASSERT_CHECK((arr[2] == 3), res);
+		ASSERT_CHECK((arr[3] == 4), res);
+
+		/// Further appends continue after the committed elements.
+		arr.push_back(5);
+
+		ASSERT_CHECK((arr.size() == 5), res);
+		ASSERT_CHECK((arr[4] == 5), res);
+	}
+
+	{
+		/// Committing nothing leaves the array unchanged.
+		PaddedPODArray<UInt64> arr;
+
+		arr.reserve_and_get_tail(8);
+		arr.commit(0);
+
+		ASSERT_CHECK((arr.size() == 0), res);
+	}
+
+	{
+		/// Repeated batches across reallocations.
+		PaddedPODArray<UInt32> arr;
+
+		for (size_t batch = 0; batch < 100; ++batch)
+		{
+			UInt32 * out = arr.reserve_and_get_tail(7);
+			for (size_t i = 0; i < 5; ++i)
+				out[i] = batch * 5 + i;
+			arr.commit(5);
+		}
+
+		ASSERT_CHECK((arr.size() == 500), res);
+		for (size_t i = 0; i < 500; ++i)
+			ASSERT_CHECK((arr[i] == i), res);
+	}
+
+	if (!res)
+		std::cerr << "Some errors were found in test 4\n";
+}
+
 int main()
 {
 	std::cout << "test 1\n";
@@ -450,6 +512,8 @@ int main()
 	test2();
 	std::cout << "test 3\n";
 	test3();
+	std::cout << "test 4\n";
+	test4();
 
 	return 0;
 }